@@ -35,6 +35,18 @@ esp_err_t nrf24_init(nrf24_t *dev, spi_host_device_t host_id, int mosi_io_num, i
     dev->ce_io_num = ce_io_num;
     dev->csn_io_num = csn_io_num;
 
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_CONFIG, &dev->config, 1));
+
+    // A radio that stayed powered across a reset can still hold payloads and flags from before it
+    NRF24_CHECK_OK(nrf24_flush_tx(dev));
+    NRF24_CHECK_OK(nrf24_flush_rx(dev));
+    uint8_t status = NRF24_MASK_RX_DR | NRF24_MASK_TX_DS | NRF24_MASK_MAX_RT; // Write 1 to clear
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_STATUS, &status, 1));
+
+    dev->power_state = (dev->config & NRF24_MASK_PWR_UP) ? NRF24_STATE_STANDBY_I : NRF24_STATE_POWER_DOWN; // CE is low at this point
+    dev->standby_timeout_us = NRF24_STANDBY_FOREVER;
+    dev->standby_since_us = esp_timer_get_time();
+
     return ESP_OK;
 }
 
@@ -88,7 +100,13 @@ esp_err_t nrf24_set_register(nrf24_t *dev, uint8_t reg, uint8_t *data, uint8_t l
     transaction.tx_buffer = tx;
     transaction.rx_buffer = NULL;
 
-    return spi_device_transmit(dev->spi_handle, &transaction);
+    NRF24_CHECK_OK(spi_device_transmit(dev->spi_handle, &transaction));
+
+    // Keep the CONFIG copy in sync no matter who writes it, the power functions rely on it
+    if((NRF24_REGISTER_MASK & reg) == NRF24_REG_CONFIG && len > 0)
+        dev->config = data[0];
+
+    return ESP_OK;
 }
 
 esp_err_t nrf24_flush_tx(nrf24_t *dev) {
@@ -119,48 +137,131 @@ esp_err_t nrf24_flush_rx(nrf24_t *dev) {
     return spi_device_transmit(dev->spi_handle, &transaction);
 }
 
+static esp_err_t nrf24_set_config(nrf24_t *dev, uint8_t config) {
+    return nrf24_set_register(dev, NRF24_REG_CONFIG, &config, 1);
+}
+
+// CE level that matches the tracked power state
+static inline int nrf24_ce_level(nrf24_t *dev) {
+    return dev->power_state == NRF24_STATE_RX || dev->power_state == NRF24_STATE_STANDBY_II || dev->power_state == NRF24_STATE_TX;
+}
+
+// Gets to standby-I from any state, waiting out the oscillator start up if coming from power down
+static esp_err_t nrf24_enter_standby(nrf24_t *dev) {
+    if(dev->power_state == NRF24_STATE_POWER_DOWN) {
+        NRF24_CHECK_OK(nrf24_set_config(dev, dev->config | NRF24_MASK_PWR_UP));
+        esp_rom_delay_us(NRF24_TPD2STBY_US);
+    } else if(dev->power_state != NRF24_STATE_STANDBY_I) {
+        NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, 0));
+    }
+
+    dev->power_state = NRF24_STATE_STANDBY_I;
+    dev->standby_since_us = esp_timer_get_time();
+    return ESP_OK;
+}
+
 esp_err_t nrf24_power_up_tx(nrf24_t *dev) {
-    uint8_t config;
-    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_CONFIG, &config, 1));
-    config = config & (~NRF24_MASK_PRIM_RX); // Set to PTX mode
-    config = config | NRF24_MASK_PWR_UP; // Power on
-    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_CONFIG, &config, 1));
-    NRF24_CHECK_OK(nrf24_flush_tx(dev));
-    ESP_LOGI(NRF24_TAG, "Powered on in PTX mode.");
+    if(dev->power_state == NRF24_STATE_STANDBY_II || dev->power_state == NRF24_STATE_TX)
+        return ESP_OK;
+
+    bool was_down = dev->power_state == NRF24_STATE_POWER_DOWN;
+    NRF24_CHECK_OK(nrf24_enter_standby(dev));
+
+    if(dev->config & NRF24_MASK_PRIM_RX)
+        NRF24_CHECK_OK(nrf24_set_config(dev, dev->config & (~NRF24_MASK_PRIM_RX))); // Set to PTX mode
+
+    // The FIFO only needs clearing when waking up, on a turnaround it holds whatever was just queued
+    if(was_down) {
+        NRF24_CHECK_OK(nrf24_flush_tx(dev));
+        ESP_LOGI(NRF24_TAG, "Powered on in PTX mode.");
+    }
 
     NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, 1)); // Start transmiting whatever is in the FIFO or go into Standby II if there isn't anything in the FIFO
-   
-    ESP_LOGI(NRF24_TAG, "Ready to transmit.");
+    dev->power_state = NRF24_STATE_STANDBY_II; // The radio waits out the PLL settling itself before the first packet goes out
+
+    ESP_LOGD(NRF24_TAG, "Ready to transmit.");
     return ESP_OK;
 }
 
 esp_err_t nrf24_power_up_rx(nrf24_t *dev) {
-    uint8_t config;
-    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_CONFIG, &config, 1));
-    config = config | NRF24_MASK_PRIM_RX; // Set to PRX mode
-    config = config | NRF24_MASK_PWR_UP; // Power on
-    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_CONFIG, &config, 1));
-    NRF24_CHECK_OK(nrf24_flush_rx(dev));
-    ESP_LOGI(NRF24_TAG, "Powered on in PRX mode.");
+    if(dev->power_state == NRF24_STATE_RX)
+        return ESP_OK;
+
+    bool was_down = dev->power_state == NRF24_STATE_POWER_DOWN;
+    NRF24_CHECK_OK(nrf24_enter_standby(dev));
+
+    if((dev->config & NRF24_MASK_PRIM_RX) == 0)
+        NRF24_CHECK_OK(nrf24_set_config(dev, dev->config | NRF24_MASK_PRIM_RX)); // Set to PRX mode
+
+    if(was_down) {
+        NRF24_CHECK_OK(nrf24_flush_rx(dev));
+        ESP_LOGI(NRF24_TAG, "Powered on in PRX mode.");
+    }
 
     NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, 1)); // Start listening for packets
+    esp_rom_delay_us(NRF24_TSTBY2A_US);
+    dev->power_state = NRF24_STATE_RX;
 
-    ESP_LOGI(NRF24_TAG, "Listening for packets.");
+    ESP_LOGD(NRF24_TAG, "Listening for packets.");
     return ESP_OK;
 }
 
 esp_err_t nrf24_power_down(nrf24_t *dev) {
     NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, 0));
 
-    uint8_t config;
-    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_CONFIG, &config, 1));
-    config = config & (~NRF24_MASK_PWR_UP); // Power off
-    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_CONFIG, &config, 1));
+    if(dev->config & NRF24_MASK_PWR_UP)
+        NRF24_CHECK_OK(nrf24_set_config(dev, dev->config & (~NRF24_MASK_PWR_UP))); // Power off
+
+    dev->power_state = NRF24_STATE_POWER_DOWN;
 
     ESP_LOGI(NRF24_TAG, "Powered down.");
     return ESP_OK;
 }
 
+// Idles in standby-I, which keeps the oscillator running so the next power up only costs the PLL settling
+esp_err_t nrf24_standby(nrf24_t *dev) {
+    NRF24_CHECK_OK(nrf24_enter_standby(dev));
+
+    if(dev->standby_timeout_us == 0)
+        return nrf24_power_down(dev);
+
+    return ESP_OK;
+}
+
+// How long to linger in standby-I before nrf24_power_tick powers down, NRF24_STANDBY_FOREVER to never power down
+void nrf24_set_standby_timeout(nrf24_t *dev, int64_t timeout_us) {
+    dev->standby_timeout_us = timeout_us;
+}
+
+// Once the TX FIFO drains or a packet runs out of retransmits there's nothing left to send, drop CE so the
+// radio idles in standby-I and the standby timeout starts counting
+esp_err_t nrf24_update_power_state(nrf24_t *dev) {
+    if(dev->power_state != NRF24_STATE_TX)
+        return ESP_OK;
+
+    uint8_t status;
+    uint8_t fifo_status;
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_STATUS, &status, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_FIFO_STATUS, &fifo_status, 1));
+    if((fifo_status & NRF24_MASK_TX_EMPTY) || (status & NRF24_MASK_MAX_RT))
+        return nrf24_enter_standby(dev);
+
+    return ESP_OK;
+}
+
+// Call periodically, powers down once the radio has been in standby-I for longer than the standby timeout
+esp_err_t nrf24_power_tick(nrf24_t *dev) {
+    NRF24_CHECK_OK(nrf24_update_power_state(dev));
+
+    if(dev->power_state != NRF24_STATE_STANDBY_I || dev->standby_timeout_us < 0)
+        return ESP_OK;
+
+    if(esp_timer_get_time() - dev->standby_since_us < dev->standby_timeout_us)
+        return ESP_OK;
+
+    return nrf24_power_down(dev);
+}
+
 esp_err_t nrf24_set_data_rate(nrf24_t *dev, enum nrf24_data_rate_t rate) {
     uint8_t rf_setup;
     NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_RF_SETUP, &rf_setup, 1));
@@ -226,7 +327,7 @@ esp_err_t nrf24_set_crc(nrf24_t *dev, enum nrf24_crc_t crc) {
             break;
     }
 
-    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_CONFIG, &config, 1));
+    NRF24_CHECK_OK(nrf24_set_config(dev, config));
 
     ESP_LOGI(NRF24_TAG, "Set CRC.");
     return ESP_OK;
@@ -503,7 +604,18 @@ esp_err_t nrf24_send_data(nrf24_t *dev, uint8_t *data, uint8_t len) {
     transaction.tx_buffer = tx;
     transaction.rx_buffer = NULL;
 
-    return spi_device_transmit(dev->spi_handle, &transaction);
+    NRF24_CHECK_OK(spi_device_transmit(dev->spi_handle, &transaction));
+
+    // Back from standby-I after a burst, PTX mode only needs CE to start sending again
+    if(dev->power_state == NRF24_STATE_STANDBY_I && (dev->config & NRF24_MASK_PRIM_RX) == 0) {
+        NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, 1));
+        dev->power_state = NRF24_STATE_TX;
+    }
+
+    if(dev->power_state == NRF24_STATE_STANDBY_II)
+        dev->power_state = NRF24_STATE_TX;
+
+    return ESP_OK;
 }
 
 int nrf24_get_data_available(nrf24_t *dev) {
@@ -524,12 +636,10 @@ esp_err_t nrf24_get_data(nrf24_t *dev, uint8_t *data, uint8_t *len) {
     NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, 0));
     
     spi_transaction_t transaction;
-    uint8_t *tx;
-    uint8_t *rx;
-
-    tx = malloc(2);
-    rx = malloc(2);
+    uint8_t tx[33];
+    uint8_t rx[33];
 
+    memset(tx, 0, 2);
     tx[0] = NRF24_CMD_R_RX_PL_WID;
 
     memset(&transaction, 0, sizeof(spi_transaction_t));
@@ -540,19 +650,17 @@ esp_err_t nrf24_get_data(nrf24_t *dev, uint8_t *data, uint8_t *len) {
     NRF24_CHECK_OK(spi_device_transmit(dev->spi_handle, &transaction));
 
     *len = rx[1];
-    free(tx);
-    free(rx);
 
     if(*len > 32) {
         ESP_LOGW(NRF24_TAG, "Got a payload width of greater than 32, clearing FIFO.");
         NRF24_CHECK_OK(nrf24_flush_rx(dev));
+        NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, nrf24_ce_level(dev)));
         return ESP_OK;
     }
 
     memset(&transaction, 0, sizeof(spi_transaction_t));
 
-    tx = malloc((*len)+1);
-    rx = malloc((*len)+1);
+    memset(tx, 0, (*len)+1);
     tx[0] = NRF24_CMD_R_RX_PAYLOAD;
 
     transaction.length = ((*len)+1) * 8;
@@ -562,9 +670,7 @@ esp_err_t nrf24_get_data(nrf24_t *dev, uint8_t *data, uint8_t *len) {
     NRF24_CHECK_OK(spi_device_transmit(dev->spi_handle, &transaction));
 
     memcpy(data, &rx[1], *len);
-    free(tx);
-    free(rx);
 
-    NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, 1));
+    NRF24_CHECK_OK(gpio_set_level(dev->ce_io_num, nrf24_ce_level(dev))); // Only resume listening if we were, the FIFO can be drained from standby too
     return ESP_OK;
 }
\ No newline at end of file
@@ -0,0 +1,213 @@
+#include "esp_nrf24_capture.h"
+#include "esp_timer.h"
+
+// Puts back everything nrf24_capture_start saved, the radio must be powered down
+static esp_err_t nrf24_capture_restore(nrf24_capture_t *cap) {
+    nrf24_t *dev = cap->dev;
+
+    ESP_LOGI(NRF24_TAG, "Restoring radio configuration...");
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_EN_AA, &cap->saved_en_aa, 1));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_EN_RXADDR, &cap->saved_en_rxaddr, 1));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_SETUP_AW, &cap->saved_setup_aw, 1));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_RF_CH, &cap->saved_rf_ch, 1));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_RF_SETUP, &cap->saved_rf_setup, 1));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_RX_ADDR_P0, cap->saved_rx_addr_p0, sizeof(cap->saved_rx_addr_p0)));
+    for(int pipe = NRF24_P0; pipe <= NRF24_P5; pipe++)
+        NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_RX_PW_P0 + pipe, &cap->saved_rx_pw[pipe], 1));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_FEATURE, &cap->saved_feature, 1));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_DYNPD, &cap->saved_dynpd, 1));
+
+    // Only the CRC bits, PWR_UP and PRIM_RX stay with the power state we just set
+    uint8_t config = (dev->config & ~(NRF24_MASK_EN_CRC | NRF24_MASK_CRCO)) | (cap->saved_config & (NRF24_MASK_EN_CRC | NRF24_MASK_CRCO));
+    return nrf24_set_register(dev, NRF24_REG_CONFIG, &config, 1);
+}
+
+static esp_err_t nrf24_capture_configure(nrf24_capture_t *cap, uint8_t channel, enum nrf24_data_rate_t rate, uint16_t address) {
+    nrf24_t *dev = cap->dev;
+
+    ESP_LOGI(NRF24_TAG, "Configuring radio for capture...");
+
+    uint8_t en_aa = 0; // Never ack what we overhear
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_EN_AA, &en_aa, 1));
+
+    // The shortest address width lets noise and preambles through as frames
+    uint8_t setup_aw = NRF24_AW_2BYTES;
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_SETUP_AW, &setup_aw, 1));
+
+    uint8_t rx_addr[2] = {address & 0xFF, address >> 8}; // LSByte first, nrf24_set_rx_address won't take a 2 byte address
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_RX_ADDR_P0, rx_addr, 2));
+
+    uint8_t en_rxaddr = NRF24_MASK_ERX_P0;
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_EN_RXADDR, &en_rxaddr, 1));
+
+    NRF24_CHECK_OK(nrf24_set_crc(dev, NRF24_CRC_DISABLED));
+    NRF24_CHECK_OK(nrf24_set_payload_length(dev, NRF24_CAPTURE_MAX_PAYLOAD));
+    NRF24_CHECK_OK(nrf24_set_data_rate(dev, rate));
+    NRF24_CHECK_OK(nrf24_set_rf_channel(dev, channel));
+
+    uint8_t header[NRF24_CAPTURE_MAGIC_LEN + 1];
+    memcpy(header, NRF24_CAPTURE_MAGIC, NRF24_CAPTURE_MAGIC_LEN);
+    header[NRF24_CAPTURE_MAGIC_LEN] = NRF24_CAPTURE_VERSION;
+    NRF24_CHECK_OK(cap->sink(cap->sink_ctx, header, sizeof(header)));
+
+    return nrf24_power_up_rx(dev);
+}
+
+esp_err_t nrf24_capture_start(nrf24_capture_t *cap, nrf24_t *dev, uint8_t channel, enum nrf24_data_rate_t rate, uint16_t address, nrf24_capture_sink_t sink, void *sink_ctx) {
+    if(sink == NULL) {
+        ESP_LOGW(NRF24_TAG, "Capture needs a sink to write frames to.");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(channel > 125) {
+        ESP_LOGW(NRF24_TAG, "Unsupported channel, maximum channel number supported is 125.");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(rate != NRF24_1MBPS && rate != NRF24_2MBPS && rate != NRF24_250KBPS) {
+        ESP_LOGW(NRF24_TAG, "Unsupported data rate.");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    cap->dev = dev;
+    cap->sink = sink;
+    cap->sink_ctx = sink_ctx;
+    cap->channel = channel;
+    cap->frames = 0;
+    cap->overflows = 0;
+
+    NRF24_CHECK_OK(nrf24_power_down(dev));
+
+    ESP_LOGI(NRF24_TAG, "Saving radio configuration...");
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_CONFIG, &cap->saved_config, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_EN_AA, &cap->saved_en_aa, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_EN_RXADDR, &cap->saved_en_rxaddr, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_SETUP_AW, &cap->saved_setup_aw, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_RF_CH, &cap->saved_rf_ch, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_RF_SETUP, &cap->saved_rf_setup, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_RX_ADDR_P0, cap->saved_rx_addr_p0, sizeof(cap->saved_rx_addr_p0)));
+    for(int pipe = NRF24_P0; pipe <= NRF24_P5; pipe++)
+        NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_RX_PW_P0 + pipe, &cap->saved_rx_pw[pipe], 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_DYNPD, &cap->saved_dynpd, 1));
+    NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_FEATURE, &cap->saved_feature, 1));
+
+    // From here on the radio isn't how we found it, so any failure puts the saved configuration back
+    esp_err_t ret = nrf24_capture_configure(cap, channel, rate, address);
+    if(ret != ESP_OK) {
+        ESP_LOGW(NRF24_TAG, "Failed to start capture, status: %d.", ret);
+        nrf24_power_down(dev);
+        nrf24_capture_restore(cap);
+        return ret;
+    }
+
+    ESP_LOGI(NRF24_TAG, "Capturing on %iMhz.", 2400 + (int)channel);
+    return ESP_OK;
+}
+
+esp_err_t nrf24_capture_set_channel(nrf24_capture_t *cap, uint8_t channel) {
+    if(channel > 125) {
+        ESP_LOGW(NRF24_TAG, "Unsupported channel, maximum channel number supported is 125.");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    // Written directly rather than through nrf24_set_rf_channel to keep logging out of channel hopping
+    uint8_t rf_ch = channel & NRF24_MASK_RF_CH;
+    NRF24_CHECK_OK(gpio_set_level(cap->dev->ce_io_num, 0));
+    NRF24_CHECK_OK(nrf24_set_register(cap->dev, NRF24_REG_RF_CH, &rf_ch, 1));
+    NRF24_CHECK_OK(gpio_set_level(cap->dev->ce_io_num, 1));
+    esp_rom_delay_us(NRF24_TSTBY2A_US); // Nothing is received on the new channel until the PLL settles
+
+    cap->channel = channel;
+    return ESP_OK;
+}
+
+// Polling transactions skip the interrupt and task switch of spi_device_transmit, which dominates short transfers
+static esp_err_t nrf24_capture_transfer(nrf24_capture_t *cap, uint8_t *tx, uint8_t *rx, size_t len) {
+    spi_transaction_t transaction;
+    memset(&transaction, 0, sizeof(spi_transaction_t));
+    transaction.length = len * 8;
+    transaction.tx_buffer = tx;
+    transaction.rx_buffer = rx;
+
+    return spi_device_polling_transmit(cap->dev->spi_handle, &transaction);
+}
+
+// Drains the RX FIFO into the sink, returns the number of frames captured or -1 on error.
+// Nothing in here logs or allocates so it can be called in a tight loop.
+int nrf24_capture_poll(nrf24_capture_t *cap) {
+    uint8_t tx[1 + NRF24_CAPTURE_MAX_PAYLOAD];
+    uint8_t rx[1 + NRF24_CAPTURE_MAX_PAYLOAD];
+    uint8_t record[NRF24_CAPTURE_MAX_RECORD];
+    int count = 0;
+
+    // Reading RPD also clocks out STATUS, which is all an idle poll needs
+    tx[0] = NRF24_CMD_R_REGISTER | NRF24_REG_RPD;
+    tx[1] = NRF24_CMD_NOP;
+    if(nrf24_capture_transfer(cap, tx, rx, 2) != ESP_OK)
+        return -1;
+
+    if((rx[0] & NRF24_MASK_RX_P_NO) == NRF24_MASK_RX_P_NO)
+        return 0;
+
+    uint8_t flags = (rx[1] & NRF24_MASK_RPD) ? NRF24_CAPTURE_FLAG_RPD : 0;
+
+    tx[0] = NRF24_CMD_R_REGISTER | NRF24_REG_FIFO_STATUS;
+    if(nrf24_capture_transfer(cap, tx, rx, 2) != ESP_OK)
+        return -1;
+
+    uint8_t overflow = 0;
+    if(rx[1] & NRF24_MASK_RX_FULL) {
+        overflow = NRF24_CAPTURE_FLAG_OVERFLOW;
+        cap->overflows++;
+    }
+
+    memset(tx, NRF24_CMD_NOP, sizeof(tx));
+    tx[0] = NRF24_CMD_R_RX_PAYLOAD;
+
+    // STATUS comes back ahead of the payload, so each read also says whether there was a frame to read.
+    // That costs one wasted read per poll instead of a FIFO_STATUS read per frame.
+    for(;;) {
+        if(nrf24_capture_transfer(cap, tx, rx, sizeof(tx)) != ESP_OK)
+            return -1;
+
+        if((rx[0] & NRF24_MASK_RX_P_NO) == NRF24_MASK_RX_P_NO)
+            break;
+
+        uint32_t timestamp = (uint32_t)esp_timer_get_time();
+
+        record[0] = NRF24_CAPTURE_RECORD_HEADER + NRF24_CAPTURE_MAX_PAYLOAD;
+        record[1] = timestamp & 0xFF;
+        record[2] = (timestamp >> 8) & 0xFF;
+        record[3] = (timestamp >> 16) & 0xFF;
+        record[4] = (timestamp >> 24) & 0xFF;
+        record[5] = cap->channel;
+        record[6] = flags | overflow;
+        memcpy(&record[1 + NRF24_CAPTURE_RECORD_HEADER], &rx[1], NRF24_CAPTURE_MAX_PAYLOAD);
+
+        if(cap->sink(cap->sink_ctx, record, sizeof(record)) != ESP_OK)
+            return -1;
+
+        cap->frames++;
+        count++;
+        overflow = 0;
+    }
+
+    tx[0] = NRF24_CMD_W_REGISTER | NRF24_REG_STATUS;
+    tx[1] = NRF24_MASK_RX_DR; // Write 1 to clear
+    if(nrf24_capture_transfer(cap, tx, rx, 2) != ESP_OK)
+        return -1;
+
+    return count;
+}
+
+esp_err_t nrf24_capture_stop(nrf24_capture_t *cap) {
+    nrf24_t *dev = cap->dev;
+
+    NRF24_CHECK_OK(nrf24_power_down(dev));
+    NRF24_CHECK_OK(nrf24_flush_rx(dev));
+
+    NRF24_CHECK_OK(nrf24_capture_restore(cap));
+
+    ESP_LOGI(NRF24_TAG, "Stopped capture, %u frames captured, %u FIFO overflows.", (unsigned)cap->frames, (unsigned)cap->overflows);
+    return ESP_OK;
+}
@@ -0,0 +1,242 @@
+#include "esp_nrf24_codec.h"
+
+static inline uint32_t nrf24_codec_zigzag(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t nrf24_codec_unzigzag(uint32_t value) {
+    return (int32_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static inline uint8_t nrf24_codec_varint_len(uint32_t value) {
+    uint8_t len = 1;
+    while(value >= 0x80) {
+        value = value >> 7;
+        len++;
+    }
+    return len;
+}
+
+// Returns the new write position, callers have already made sure the varint fits
+static inline uint8_t nrf24_codec_put_varint(uint8_t *frame, uint8_t pos, uint32_t value) {
+    while(value >= 0x80) {
+        frame[pos++] = (uint8_t)(value | 0x80);
+        value = value >> 7;
+    }
+    frame[pos++] = (uint8_t)value;
+    return pos;
+}
+
+// Returns the new read position, or 0 if the varint is truncated or too long
+static inline uint8_t nrf24_codec_get_varint(const uint8_t *frame, uint8_t pos, uint8_t len, uint32_t *value) {
+    uint32_t result = 0;
+    for(int shift = 0; shift < 35; shift += 7) {
+        if(pos >= len)
+            return 0;
+        uint8_t byte = frame[pos++];
+        result = result | ((uint32_t)(byte & 0x7F) << shift);
+        if((byte & 0x80) == 0) {
+            *value = result;
+            return pos;
+        }
+    }
+    return 0;
+}
+
+esp_err_t nrf24_codec_init(nrf24_codec_t *codec, uint8_t field_count, uint8_t keyframe_interval) {
+    if(field_count == 0 || field_count > NRF24_CODEC_MAX_FIELDS) {
+        ESP_LOGW(NRF24_TAG, "Invalid codec field count, valid counts are 1-%i.", NRF24_CODEC_MAX_FIELDS);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(keyframe_interval == 0) {
+        ESP_LOGW(NRF24_TAG, "Invalid keyframe interval, must be at least 1 (1 being every frame).");
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(codec, 0, sizeof(nrf24_codec_t));
+    codec->field_count = field_count;
+    codec->keyframe_interval = keyframe_interval;
+
+    return ESP_OK;
+}
+
+void nrf24_codec_force_keyframe(nrf24_codec_t *codec) {
+    codec->frames_since_keyframe = 0;
+}
+
+esp_err_t nrf24_codec_encode(nrf24_codec_t *codec, const int32_t *values, uint8_t frames[][NRF24_CODEC_MAX_FRAME], uint8_t *lens, uint8_t *frame_count) {
+    bool keyframe = codec->frames_since_keyframe == 0;
+    uint32_t zigzag[NRF24_CODEC_MAX_FIELDS];
+    uint8_t zigzag_len[NRF24_CODEC_MAX_FIELDS];
+
+    // Work out every field's size up front so each frame can be packed in one pass
+    for(int i = 0; i < codec->field_count; i++) {
+        if(keyframe) {
+            zigzag[i] = nrf24_codec_zigzag(values[i]);
+            zigzag_len[i] = nrf24_codec_varint_len(zigzag[i]);
+        } else {
+            int32_t delta = (int32_t)((uint32_t)values[i] - (uint32_t)codec->last[i]);
+            zigzag[i] = nrf24_codec_zigzag(delta);
+            zigzag_len[i] = delta == 0 ? 0 : nrf24_codec_varint_len(zigzag[i]); // Unchanged fields only cost their bitmap bit
+        }
+    }
+
+    uint8_t count = 0;
+    uint8_t offset = 0;
+    while(offset < codec->field_count) {
+        uint8_t used = NRF24_CODEC_FRAME_HEADER;
+        uint8_t fields = 0;
+        while(offset + fields < codec->field_count) {
+            uint8_t cost = zigzag_len[offset + fields];
+            if(!keyframe && fields % 8 == 0)
+                cost++; // Next bitmap byte
+            if(used + cost > NRF24_CODEC_MAX_FRAME)
+                break;
+            used += cost;
+            fields++;
+        }
+
+        uint8_t *frame = frames[count];
+        frame[0] = codec->seq & NRF24_CODEC_MASK_SEQ;
+        if(keyframe)
+            frame[0] = frame[0] | NRF24_CODEC_MASK_KEYFRAME;
+        if(offset + fields == codec->field_count)
+            frame[0] = frame[0] | NRF24_CODEC_MASK_LAST;
+        frame[1] = offset;
+        frame[2] = fields;
+
+        uint8_t pos = NRF24_CODEC_FRAME_HEADER;
+        if(!keyframe) {
+            uint8_t bitmap_len = (fields + 7) / 8;
+            memset(&frame[pos], 0, bitmap_len);
+            for(int i = 0; i < fields; i++) {
+                if(zigzag_len[offset + i] != 0)
+                    frame[pos + i/8] = frame[pos + i/8] | (1 << (i%8));
+            }
+            pos = pos + bitmap_len;
+        }
+
+        for(int i = 0; i < fields; i++) {
+            if(zigzag_len[offset + i] != 0)
+                pos = nrf24_codec_put_varint(frame, pos, zigzag[offset + i]);
+        }
+
+        lens[count] = pos;
+        count++;
+        offset += fields;
+    }
+
+    memcpy(codec->last, values, codec->field_count * sizeof(int32_t));
+    codec->seq = (codec->seq + 1) & NRF24_CODEC_MASK_SEQ;
+    codec->frames_since_keyframe = (codec->frames_since_keyframe + 1) % codec->keyframe_interval;
+
+    *frame_count = count;
+    return ESP_OK;
+}
+
+// Anything lost or out of place means the previous values are stale, wait for the next keyframe
+static esp_err_t nrf24_codec_lose_sync(nrf24_codec_t *codec, esp_err_t ret) {
+    codec->synced = false;
+    codec->assembling = false;
+    return ret;
+}
+
+esp_err_t nrf24_codec_decode(nrf24_codec_t *codec, const uint8_t *frame, uint8_t len, int32_t *values) {
+    if(len < NRF24_CODEC_FRAME_HEADER || len > NRF24_CODEC_MAX_FRAME)
+        return nrf24_codec_lose_sync(codec, ESP_ERR_INVALID_SIZE);
+
+    bool keyframe = (frame[0] & NRF24_CODEC_MASK_KEYFRAME) != 0;
+    uint8_t seq = frame[0] & NRF24_CODEC_MASK_SEQ;
+    uint8_t offset = frame[1];
+    uint8_t fields = frame[2];
+
+    if(fields == 0 || offset + fields > codec->field_count)
+        return nrf24_codec_lose_sync(codec, ESP_ERR_INVALID_SIZE);
+
+    if(offset == 0) {
+        if(!keyframe && (!codec->synced || seq != codec->seq))
+            return nrf24_codec_lose_sync(codec, ESP_ERR_INVALID_STATE);
+
+        memcpy(codec->pending, codec->last, codec->field_count * sizeof(int32_t));
+        codec->pending_seq = seq;
+        codec->pending_keyframe = keyframe;
+        codec->pending_next_field = 0;
+        codec->assembling = true;
+    } else if(!codec->assembling || seq != codec->pending_seq || keyframe != codec->pending_keyframe || offset != codec->pending_next_field) {
+        return nrf24_codec_lose_sync(codec, ESP_ERR_INVALID_STATE);
+    }
+
+    uint32_t value;
+    uint8_t pos = NRF24_CODEC_FRAME_HEADER;
+    uint8_t bitmap = pos;
+
+    if(!keyframe) {
+        pos = pos + (fields + 7) / 8;
+        if(len < pos)
+            return nrf24_codec_lose_sync(codec, ESP_ERR_INVALID_SIZE);
+    }
+
+    for(int i = 0; i < fields; i++) {
+        if(!keyframe && (frame[bitmap + i/8] & (1 << (i%8))) == 0)
+            continue;
+
+        pos = nrf24_codec_get_varint(frame, pos, len, &value);
+        if(pos == 0)
+            return nrf24_codec_lose_sync(codec, ESP_ERR_INVALID_SIZE);
+
+        if(keyframe)
+            codec->pending[offset + i] = nrf24_codec_unzigzag(value);
+        else
+            codec->pending[offset + i] = (int32_t)((uint32_t)codec->pending[offset + i] + (uint32_t)nrf24_codec_unzigzag(value));
+    }
+
+    codec->pending_next_field = offset + fields;
+    if((frame[0] & NRF24_CODEC_MASK_LAST) == 0)
+        return ESP_ERR_NOT_FINISHED;
+
+    if(codec->pending_next_field != codec->field_count)
+        return nrf24_codec_lose_sync(codec, ESP_ERR_INVALID_SIZE);
+
+    memcpy(codec->last, codec->pending, codec->field_count * sizeof(int32_t));
+    memcpy(values, codec->pending, codec->field_count * sizeof(int32_t));
+    codec->seq = (seq + 1) & NRF24_CODEC_MASK_SEQ;
+    codec->synced = true;
+    codec->assembling = false;
+
+    return ESP_OK;
+}
+
+#ifdef ESP_PLATFORM
+esp_err_t nrf24_codec_send(nrf24_t *dev, nrf24_codec_t *codec, const int32_t *values) {
+    uint8_t frames[NRF24_CODEC_MAX_FRAMES][NRF24_CODEC_MAX_FRAME];
+    uint8_t lens[NRF24_CODEC_MAX_FRAMES];
+    uint8_t count;
+
+    NRF24_CHECK_OK(nrf24_codec_encode(codec, values, frames, lens, &count));
+
+    for(int i = 0; i < count; i++) {
+        // A sample can be more frames than the 3 deep TX FIFO holds, W_TX_PAYLOAD into a full FIFO is dropped
+        uint8_t status;
+        int64_t start = esp_timer_get_time();
+        do {
+            NRF24_CHECK_OK(nrf24_get_register(dev, NRF24_REG_STATUS, &status, 1));
+            if(esp_timer_get_time() - start > NRF24_CODEC_SEND_TIMEOUT_US)
+                return ESP_ERR_TIMEOUT;
+        } while(status & NRF24_MASK_TX_FULL);
+
+        NRF24_CHECK_OK(nrf24_send_data(dev, frames[i], lens[i]));
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t nrf24_codec_get(nrf24_t *dev, nrf24_codec_t *codec, int32_t *values) {
+    uint8_t frame[NRF24_CODEC_MAX_FRAME];
+    uint8_t len;
+
+    NRF24_CHECK_OK(nrf24_get_data(dev, frame, &len));
+
+    return nrf24_codec_decode(codec, frame, len, values);
+}
+#endif
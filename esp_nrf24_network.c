@@ -0,0 +1,410 @@
+#include "esp_nrf24_network.h"
+
+bool nrf24_network_valid_address(uint16_t node) {
+    for(int level = 0; level < NRF24_NETWORK_MAX_DEPTH; level++) {
+        uint8_t digit = node & 0b111;
+        node = node >> 3;
+        if(digit == 0)
+            return node == 0; // No children below a missing level
+        if(digit > NRF24_NETWORK_MAX_CHILDREN)
+            return false;
+    }
+    return node == 0;
+}
+
+int nrf24_network_depth(uint16_t node) {
+    int depth = 0;
+    while(node != 0) {
+        node = node >> 3;
+        depth++;
+    }
+    return depth;
+}
+
+static inline uint16_t nrf24_network_level_mask(int depth) {
+    return (1 << (3*depth)) - 1;
+}
+
+// Works out who to hand a frame for to_node to, returns false if it can't be routed from here
+bool nrf24_network_next_hop(uint16_t node, uint16_t to_node, uint16_t *hop_node, uint8_t *hop_pipe) {
+    int depth = nrf24_network_depth(node);
+
+    if(nrf24_network_depth(to_node) > depth && (to_node & nrf24_network_level_mask(depth)) == node) {
+        // Down to the child on the way, children listen for their parent on pipe 0
+        *hop_node = to_node & nrf24_network_level_mask(depth + 1);
+        *hop_pipe = 0;
+        return true;
+    }
+
+    if(node == NRF24_NETWORK_GATEWAY)
+        return false;
+
+    // Up to the parent, which listens for us on the pipe matching our last digit
+    *hop_node = node & nrf24_network_level_mask(depth - 1);
+    *hop_pipe = (node >> (3*(depth - 1))) & 0b111;
+    return true;
+}
+
+void nrf24_network_put_header(uint8_t *frame, const nrf24_network_header_t *header) {
+    frame[0] = header->to_node & 0xFF;
+    frame[1] = header->to_node >> 8;
+    frame[2] = header->from_node & 0xFF;
+    frame[3] = header->from_node >> 8;
+    frame[4] = header->id;
+    frame[5] = header->type;
+    frame[6] = header->hops;
+    frame[7] = header->queue_us & 0xFF;
+    frame[8] = (header->queue_us >> 8) & 0xFF;
+    frame[9] = (header->queue_us >> 16) & 0xFF;
+    frame[10] = (header->queue_us >> 24) & 0xFF;
+}
+
+void nrf24_network_get_header(const uint8_t *frame, nrf24_network_header_t *header) {
+    header->to_node = (uint16_t)frame[0] | ((uint16_t)frame[1] << 8);
+    header->from_node = (uint16_t)frame[2] | ((uint16_t)frame[3] << 8);
+    header->id = frame[4];
+    header->type = frame[5];
+    header->hops = frame[6];
+    header->queue_us = (uint32_t)frame[7] | ((uint32_t)frame[8] << 8) | ((uint32_t)frame[9] << 16) | ((uint32_t)frame[10] << 24);
+}
+
+nrf24_network_entry_t *nrf24_network_queue_push(nrf24_network_queue_t *queue) {
+    if(queue->count >= NRF24_NETWORK_QUEUE_LEN)
+        return NULL;
+
+    nrf24_network_entry_t *entry = &queue->entries[(queue->head + queue->count) % NRF24_NETWORK_QUEUE_LEN];
+    queue->count++;
+    return entry;
+}
+
+nrf24_network_entry_t *nrf24_network_queue_peek(nrf24_network_queue_t *queue) {
+    if(queue->count == 0)
+        return NULL;
+
+    return &queue->entries[queue->head];
+}
+
+void nrf24_network_queue_pop(nrf24_network_queue_t *queue) {
+    queue->head = (queue->head + 1) % NRF24_NETWORK_QUEUE_LEN;
+    queue->count--;
+}
+
+// Moves the front entry to the back, so a frame waiting on a retry doesn't hold up the ones behind it
+void nrf24_network_queue_rotate(nrf24_network_queue_t *queue) {
+    if(queue->count < 2)
+        return;
+
+    queue->entries[(queue->head + queue->count) % NRF24_NETWORK_QUEUE_LEN] = queue->entries[queue->head];
+    queue->head = (queue->head + 1) % NRF24_NETWORK_QUEUE_LEN;
+}
+
+esp_err_t nrf24_network_init_ops(nrf24_network_t *net, const nrf24_network_ops_t *ops, void *radio, uint16_t node_address) {
+    if(!nrf24_network_valid_address(node_address)) {
+        ESP_LOGW(NRF24_TAG, "Invalid node address 0%o, each octal digit must be 1-%i with at most %i digits.", node_address, NRF24_NETWORK_MAX_CHILDREN, NRF24_NETWORK_MAX_DEPTH);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(net, 0, sizeof(nrf24_network_t));
+    net->ops = ops;
+    net->radio = radio;
+    net->node_address = node_address;
+
+    return ESP_OK;
+}
+
+static bool nrf24_network_seen(nrf24_network_t *net, const nrf24_network_header_t *header) {
+    for(int i = 0; i < net->seen_count; i++) {
+        if(net->seen[i].from_node == header->from_node && net->seen[i].id == header->id)
+            return true;
+    }
+    return false;
+}
+
+// Overwrites the oldest pair once the table is full
+static void nrf24_network_remember(nrf24_network_t *net, const nrf24_network_header_t *header) {
+    net->seen[net->seen_head].from_node = header->from_node;
+    net->seen[net->seen_head].id = header->id;
+    net->seen_head = (net->seen_head + 1) % NRF24_NETWORK_SEEN_LEN;
+    if(net->seen_count < NRF24_NETWORK_SEEN_LEN)
+        net->seen_count++;
+}
+
+static void nrf24_network_receive(nrf24_network_t *net, uint8_t *frame, uint8_t len) {
+    nrf24_network_header_t header;
+    nrf24_network_entry_t *entry;
+
+    if(len < NRF24_NETWORK_HEADER_LEN || len > NRF24_NETWORK_FRAME_LEN) {
+        net->stats.dropped_invalid++;
+        return;
+    }
+
+    nrf24_network_get_header(frame, &header);
+    if(!nrf24_network_valid_address(header.to_node) || header.hops >= NRF24_NETWORK_MAX_HOPS) {
+        net->stats.dropped_invalid++;
+        return;
+    }
+
+    if(nrf24_network_seen(net, &header)) {
+        net->stats.dropped_duplicate++;
+        return;
+    }
+
+    bool local = header.to_node == net->node_address;
+    if(local) {
+        entry = nrf24_network_queue_push(&net->rx_queue);
+    } else {
+        entry = nrf24_network_queue_push(&net->tx_queue);
+        header.hops++;
+        nrf24_network_put_header(frame, &header);
+    }
+
+    if(entry == NULL) {
+        net->stats.dropped_queue_full++;
+        return;
+    }
+
+    if(local)
+        net->stats.received++;
+    else
+        net->stats.forwarded++;
+
+    nrf24_network_remember(net, &header);
+
+    memcpy(entry->frame, frame, len);
+    entry->len = len;
+    entry->retries = 0;
+    entry->enqueued_us = net->ops->time_us(net);
+}
+
+// Call often, moves received frames into the queues and sends what is waiting for the next hop
+esp_err_t nrf24_network_update(nrf24_network_t *net) {
+    uint8_t frame[NRF24_NETWORK_FRAME_LEN];
+    uint8_t len;
+    int available;
+
+    while((available = net->ops->available(net)) > 0) {
+        NRF24_CHECK_OK(net->ops->receive(net, frame, &len));
+        nrf24_network_receive(net, frame, len);
+    }
+    if(available < 0)
+        return ESP_FAIL;
+
+    // Each queued frame gets at most one look per update, frames for a hop that just failed are skipped
+    // so one unreachable neighbour doesn't cost an ack timeout per frame or hold up the others.
+    bool hop_failed = false;
+    uint16_t failed_node = 0;
+    uint8_t failed_pipe = 0;
+    int pending = net->tx_queue.count;
+
+    while(pending-- > 0) {
+        nrf24_network_entry_t *entry = nrf24_network_queue_peek(&net->tx_queue);
+        nrf24_network_header_t header;
+        uint16_t hop_node;
+        uint8_t hop_pipe;
+
+        nrf24_network_get_header(entry->frame, &header);
+        if(!nrf24_network_next_hop(net->node_address, header.to_node, &hop_node, &hop_pipe)) {
+            net->stats.dropped_invalid++;
+            nrf24_network_queue_pop(&net->tx_queue);
+            continue;
+        }
+
+        if(hop_failed && hop_node == failed_node && hop_pipe == failed_pipe) {
+            nrf24_network_queue_rotate(&net->tx_queue);
+            continue;
+        }
+
+        // Charge the time since it was queued (or last tried) to the frame
+        int64_t now = net->ops->time_us(net);
+        header.queue_us = header.queue_us + (uint32_t)(now - entry->enqueued_us);
+        entry->enqueued_us = now;
+        nrf24_network_put_header(entry->frame, &header);
+
+        esp_err_t ret = net->ops->transmit(net, hop_node, hop_pipe, entry->frame, entry->len);
+        if(ret == ESP_ERR_TIMEOUT) {
+            hop_failed = true;
+            failed_node = hop_node;
+            failed_pipe = hop_pipe;
+
+            entry->retries++;
+            if(entry->retries < NRF24_NETWORK_MAX_RETRIES) {
+                nrf24_network_queue_rotate(&net->tx_queue); // Try again next update, behind everything else
+                continue;
+            }
+
+            ESP_LOGW(NRF24_TAG, "No ack from node 0%o, dropping frame for 0%o.", hop_node, header.to_node);
+            net->stats.dropped_no_ack++;
+        } else {
+            NRF24_CHECK_OK(ret);
+            net->stats.sent++;
+        }
+
+        nrf24_network_queue_pop(&net->tx_queue);
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t nrf24_network_write(nrf24_network_t *net, uint16_t to_node, uint8_t type, const uint8_t *data, uint8_t len) {
+    if(!nrf24_network_valid_address(to_node) || to_node == net->node_address) {
+        ESP_LOGW(NRF24_TAG, "Invalid destination node 0%o.", to_node);
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if(len > NRF24_NETWORK_MAX_PAYLOAD) {
+        ESP_LOGW(NRF24_TAG, "Invalid payload length, valid lengths are 0-%i.", NRF24_NETWORK_MAX_PAYLOAD);
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    nrf24_network_entry_t *entry = nrf24_network_queue_push(&net->tx_queue);
+    if(entry == NULL) {
+        net->stats.dropped_queue_full++;
+        return ESP_ERR_NO_MEM;
+    }
+
+    nrf24_network_header_t header = {
+        .to_node = to_node,
+        .from_node = net->node_address,
+        .id = net->next_id++,
+        .type = type,
+        .hops = 0,
+        .queue_us = 0
+    };
+    nrf24_network_put_header(entry->frame, &header);
+    memcpy(&entry->frame[NRF24_NETWORK_HEADER_LEN], data, len);
+    entry->len = NRF24_NETWORK_HEADER_LEN + len;
+    entry->retries = 0;
+    entry->enqueued_us = net->ops->time_us(net);
+
+    return ESP_OK;
+}
+
+int nrf24_network_available(nrf24_network_t *net) {
+    return net->rx_queue.count;
+}
+
+esp_err_t nrf24_network_read(nrf24_network_t *net, nrf24_network_header_t *header, uint8_t *data, uint8_t *len) {
+    nrf24_network_entry_t *entry = nrf24_network_queue_peek(&net->rx_queue);
+    if(entry == NULL)
+        return ESP_ERR_NOT_FOUND;
+
+    nrf24_network_get_header(entry->frame, header);
+    *len = entry->len - NRF24_NETWORK_HEADER_LEN;
+    memcpy(data, &entry->frame[NRF24_NETWORK_HEADER_LEN], *len);
+
+    nrf24_network_queue_pop(&net->rx_queue);
+    return ESP_OK;
+}
+#ifdef ESP_PLATFORM
+// LSByte of each pipe's address, pipes 1-5 share the rest of the address so only this tells them apart
+static const uint8_t nrf24_network_pipe_bytes[6] = {0xC3, 0x3C, 0x33, 0xCE, 0x3E, 0xE3};
+
+// Address is MSByte first, same as nrf24_set_rx_address
+static void nrf24_network_pipe_address(uint16_t node, uint8_t pipe, uint8_t *address) {
+    address[0] = 0xCC;
+    address[1] = 0xCE;
+    address[2] = node >> 8;
+    address[3] = node & 0xFF;
+    address[4] = nrf24_network_pipe_bytes[pipe];
+}
+
+// Sends one frame to the next hop and waits for its auto acknowledge, then goes back to listening
+static esp_err_t nrf24_network_radio_transmit(nrf24_network_t *net, uint16_t hop_node, uint8_t hop_pipe, uint8_t *frame, uint8_t len) {
+    nrf24_t *dev = net->radio;
+    uint8_t address[5];
+    uint8_t status = 0;
+    esp_err_t ret;
+    esp_err_t err;
+
+    // Written straight to the registers rather than through nrf24_set_tx_address to keep logging off the per frame path
+    nrf24_network_pipe_address(hop_node, hop_pipe, address);
+    nrf24_flip_bytes(address, sizeof(address));
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_TX_ADDR, address, sizeof(address)));
+
+    ret = nrf24_set_register(dev, NRF24_REG_RX_ADDR_P0, address, sizeof(address)); // The ack comes back on pipe 0
+    if(ret == ESP_OK)
+        ret = nrf24_power_up_tx(dev);
+    if(ret == ESP_OK)
+        ret = nrf24_send_data(dev, frame, len);
+
+    int64_t start = esp_timer_get_time();
+    while(ret == ESP_OK && (status & (NRF24_MASK_TX_DS | NRF24_MASK_MAX_RT)) == 0) {
+        ret = nrf24_get_register(dev, NRF24_REG_STATUS, &status, 1);
+        if(esp_timer_get_time() - start > NRF24_NETWORK_ACK_TIMEOUT_US)
+            break;
+    }
+
+    if(ret == ESP_OK && (status & NRF24_MASK_TX_DS) == 0)
+        ret = ESP_ERR_TIMEOUT;
+
+    // Every path ends up here so a failure part way through can't leave us deaf in PTX on the hop's address.
+    // Radio errors take priority over a missing ack.
+    if(ret != ESP_OK && (err = nrf24_flush_tx(dev)) != ESP_OK)
+        ret = err;
+
+    status = NRF24_MASK_TX_DS | NRF24_MASK_MAX_RT; // Write 1 to clear
+    if((err = nrf24_set_register(dev, NRF24_REG_STATUS, &status, 1)) != ESP_OK)
+        ret = err;
+
+    nrf24_network_pipe_address(net->node_address, NRF24_P0, address);
+    nrf24_flip_bytes(address, sizeof(address));
+    if((err = nrf24_set_register(dev, NRF24_REG_RX_ADDR_P0, address, sizeof(address))) != ESP_OK)
+        ret = err;
+
+    if((err = nrf24_power_up_rx(dev)) != ESP_OK)
+        ret = err;
+
+    return ret;
+}
+
+static int nrf24_network_radio_available(nrf24_network_t *net) {
+    return nrf24_get_data_available(net->radio);
+}
+
+static esp_err_t nrf24_network_radio_receive(nrf24_network_t *net, uint8_t *frame, uint8_t *len) {
+    return nrf24_get_data(net->radio, frame, len);
+}
+
+static int64_t nrf24_network_radio_time_us(nrf24_network_t *net) {
+    return esp_timer_get_time();
+}
+
+static const nrf24_network_ops_t nrf24_network_radio_ops = {
+    .transmit = nrf24_network_radio_transmit,
+    .available = nrf24_network_radio_available,
+    .receive = nrf24_network_radio_receive,
+    .time_us = nrf24_network_radio_time_us
+};
+
+esp_err_t nrf24_network_init(nrf24_network_t *net, nrf24_t *dev, uint16_t node_address) {
+    NRF24_CHECK_OK(nrf24_network_init_ops(net, &nrf24_network_radio_ops, dev, node_address));
+
+    ESP_LOGI(NRF24_TAG, "Configuring radio as network node 0%o...", node_address);
+
+    NRF24_CHECK_OK(nrf24_power_down(dev));
+
+    uint8_t en_aa = NRF24_MASK_ERX_ALL; // Auto acknowledge on every pipe gives us the per hop acks
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_EN_AA, &en_aa, 1));
+
+    uint8_t setup_aw = NRF24_AW_5BYTES;
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_SETUP_AW, &setup_aw, 1));
+
+    uint8_t setup_retr = NRF24_NETWORK_SETUP_RETR;
+    NRF24_CHECK_OK(nrf24_set_register(dev, NRF24_REG_SETUP_RETR, &setup_retr, 1));
+
+    NRF24_CHECK_OK(nrf24_set_crc(dev, NRF24_CRC_2BYTES));
+    NRF24_CHECK_OK(nrf24_set_payload_length(dev, 0));
+
+    uint8_t address[5];
+    for(int pipe = NRF24_P0; pipe <= NRF24_P5; pipe++) {
+        nrf24_network_pipe_address(node_address, pipe, address);
+        NRF24_CHECK_OK(nrf24_set_rx_address(dev, pipe, address, sizeof(address)));
+    }
+
+    NRF24_CHECK_OK(nrf24_enable_rx_pipe(dev, NRF24_ALL_PIPES));
+    NRF24_CHECK_OK(nrf24_power_up_rx(dev));
+
+    ESP_LOGI(NRF24_TAG, "Joined network.");
+    return ESP_OK;
+}
+#endif
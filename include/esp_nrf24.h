@@ -1,13 +1,18 @@
+#pragma once
+
 #include "hal/spi_types.h"
 #include "driver/spi_common.h"
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "esp_log.h"
 #include "esp_err.h"
+#include "esp_timer.h"
+#include "esp_rom_sys.h"
 
 #include "esp_nrf24_map.h"
 
 #include <inttypes.h>
+#include <stdbool.h>
 #include <string.h>
 
 #ifdef __cplusplus
@@ -19,6 +24,10 @@ extern "C" {
 
 #define NRF24_CHECK_OK(ret) if((ret) != ESP_OK) return (ret)
 
+#define NRF24_TPD2STBY_US 1500 // Power down to standby-I, crystal oscillator start up
+#define NRF24_TSTBY2A_US 130 // Standby to RX/TX, PLL settling
+#define NRF24_STANDBY_FOREVER -1
+
 enum nrf24_data_rate_t {
     NRF24_1MBPS = 0,
     NRF24_2MBPS,
@@ -41,11 +50,23 @@ enum nrf24_data_pipe_t {
     NRF24_ALL_PIPES
 };
 
+enum nrf24_power_state_t {
+    NRF24_STATE_POWER_DOWN = 0,
+    NRF24_STATE_STANDBY_I, // Powered up with CE low
+    NRF24_STATE_STANDBY_II, // PTX with CE high, transmits as soon as the TX FIFO has data
+    NRF24_STATE_RX, // PRX with CE high
+    NRF24_STATE_TX // PTX with data handed over, nrf24_update_power_state drops to standby-I once the TX FIFO drains or MAX_RT is hit
+};
+
 typedef struct {
     spi_host_device_t host_id;
     spi_device_handle_t spi_handle;
     int ce_io_num;
     int csn_io_num;
+    enum nrf24_power_state_t power_state;
+    uint8_t config; // Copy of the CONFIG register so state changes don't need to read it back
+    int64_t standby_timeout_us;
+    int64_t standby_since_us;
 } nrf24_t;
 
 esp_err_t nrf24_init(nrf24_t *dev, spi_host_device_t host_id, int mosi_io_num, int miso_io_num, int sclk_io_num, int ce_io_num, int csn_io_num);
@@ -60,6 +81,10 @@ esp_err_t nrf24_flush_rx(nrf24_t *dev);
 esp_err_t nrf24_power_up_tx(nrf24_t *dev);
 esp_err_t nrf24_power_up_rx(nrf24_t *dev);
 esp_err_t nrf24_power_down(nrf24_t *dev);
+esp_err_t nrf24_standby(nrf24_t *dev);
+void nrf24_set_standby_timeout(nrf24_t *dev, int64_t timeout_us);
+esp_err_t nrf24_update_power_state(nrf24_t *dev);
+esp_err_t nrf24_power_tick(nrf24_t *dev);
 
 esp_err_t nrf24_set_data_rate(nrf24_t *dev, enum nrf24_data_rate_t rate);
 esp_err_t nrf24_set_crc(nrf24_t *dev, enum nrf24_crc_t crc);
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "esp_nrf24.h"
+#include "esp_nrf24_capture_format.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Address matched in capture mode, with a 2 byte address width this lines up with the tail of the preamble
+#define NRF24_CAPTURE_DEFAULT_ADDRESS 0x00AA
+
+// Called from nrf24_capture_poll for every record, must not block for long or the RX FIFO will overflow at 2Mbps
+typedef esp_err_t (*nrf24_capture_sink_t)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct {
+    nrf24_t *dev;
+    nrf24_capture_sink_t sink;
+    void *sink_ctx;
+    uint8_t channel;
+    uint32_t frames;
+    uint32_t overflows;
+
+    // Registers capture mode changes, put back by nrf24_capture_stop
+    uint8_t saved_config;
+    uint8_t saved_en_aa;
+    uint8_t saved_en_rxaddr;
+    uint8_t saved_setup_aw;
+    uint8_t saved_rf_ch;
+    uint8_t saved_rf_setup;
+    uint8_t saved_rx_addr_p0[5];
+    uint8_t saved_rx_pw[6];
+    uint8_t saved_dynpd;
+    uint8_t saved_feature;
+} nrf24_capture_t;
+
+esp_err_t nrf24_capture_start(nrf24_capture_t *cap, nrf24_t *dev, uint8_t channel, enum nrf24_data_rate_t rate, uint16_t address, nrf24_capture_sink_t sink, void *sink_ctx);
+esp_err_t nrf24_capture_set_channel(nrf24_capture_t *cap, uint8_t channel);
+int nrf24_capture_poll(nrf24_capture_t *cap);
+esp_err_t nrf24_capture_stop(nrf24_capture_t *cap);
+
+#ifdef __cplusplus
+}
+#endif
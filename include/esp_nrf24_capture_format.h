@@ -0,0 +1,25 @@
+#pragma once
+
+// Capture stream format, kept free of ESP-IDF includes so host tools can use it too.
+//
+// The stream starts with the magic and a version byte, followed by records:
+//   u8  length      number of bytes that follow in this record
+//   u32 timestamp   microseconds since boot, little endian, wraps every ~71 minutes
+//   u8  channel     RF channel the frame was heard on (2400 + channel Mhz)
+//   u8  flags       NRF24_CAPTURE_FLAG_*
+//   u8  payload[length - NRF24_CAPTURE_RECORD_HEADER]
+//
+// There is no IRQ line to timestamp arrivals, so the timestamp is when the frame was read out of the RX FIFO.
+// Up to 3 frames can wait in the FIFO, so it trails the air time by up to one poll interval.
+// RPD is sampled once per poll and only reflects the most recent reception, every record from that poll carries it.
+
+#define NRF24_CAPTURE_MAGIC "NRF24CAP"
+#define NRF24_CAPTURE_MAGIC_LEN 8
+#define NRF24_CAPTURE_VERSION 1
+
+#define NRF24_CAPTURE_RECORD_HEADER 6
+#define NRF24_CAPTURE_MAX_PAYLOAD 32
+#define NRF24_CAPTURE_MAX_RECORD (1 + NRF24_CAPTURE_RECORD_HEADER + NRF24_CAPTURE_MAX_PAYLOAD)
+
+#define NRF24_CAPTURE_FLAG_RPD (1<<0) // Per poll, see above
+#define NRF24_CAPTURE_FLAG_OVERFLOW (1<<1) // RX FIFO was full before this frame was read, frames may have been lost
@@ -0,0 +1,68 @@
+#pragma once
+
+#ifdef ESP_PLATFORM
+#include "esp_nrf24.h"
+#else
+// Host builds (see tools/) only get the encoder and decoder
+#include "esp_err.h"
+#include "esp_log.h"
+#include <stdint.h>
+#include <string.h>
+#define NRF24_TAG "NRF24"
+#endif
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NRF24_CODEC_MAX_FRAME 32
+#define NRF24_CODEC_MAX_FIELDS 32
+// Samples that don't fit one payload are split across frames, every frame carries at least 5 fields
+#define NRF24_CODEC_MAX_FRAMES ((NRF24_CODEC_MAX_FIELDS + 4) / 5)
+
+// Every frame starts with a header byte, the index of its first field and how many fields it carries.
+// Keyframes follow that with the fields, delta frames with a changed-field bitmap and the non zero deltas.
+// All frames of one sample share a sequence number, the last one is flagged so the decoder knows the sample is complete.
+#define NRF24_CODEC_FRAME_HEADER 3
+#define NRF24_CODEC_MASK_KEYFRAME (1<<7)
+#define NRF24_CODEC_MASK_LAST (1<<6)
+#define NRF24_CODEC_MASK_SEQ (0b00111111)
+
+// State for one direction of one telemetry stream, use one for encoding on the sender and one for decoding on the receiver
+typedef struct {
+    int32_t last[NRF24_CODEC_MAX_FIELDS];
+    uint8_t field_count;
+    uint8_t keyframe_interval;
+    uint8_t frames_since_keyframe;
+    uint8_t seq;
+    bool synced;
+
+    // Decoder only, the sample being put back together
+    int32_t pending[NRF24_CODEC_MAX_FIELDS];
+    uint8_t pending_seq;
+    uint8_t pending_next_field;
+    bool pending_keyframe;
+    bool assembling;
+} nrf24_codec_t;
+
+esp_err_t nrf24_codec_init(nrf24_codec_t *codec, uint8_t field_count, uint8_t keyframe_interval);
+void nrf24_codec_force_keyframe(nrf24_codec_t *codec);
+
+// Encodes one sample into 1 to NRF24_CODEC_MAX_FRAMES frames
+esp_err_t nrf24_codec_encode(nrf24_codec_t *codec, const int32_t *values, uint8_t frames[][NRF24_CODEC_MAX_FRAME], uint8_t *lens, uint8_t *frame_count);
+// Returns ESP_ERR_NOT_FINISHED until the last frame of a sample arrives, then ESP_OK with the sample in values
+esp_err_t nrf24_codec_decode(nrf24_codec_t *codec, const uint8_t *frame, uint8_t len, int32_t *values);
+
+#ifdef ESP_PLATFORM
+// Frames vary in length, so these need dynamic payload length enabled with nrf24_set_payload_length(dev, 0).
+// nrf24_codec_get decodes one received frame, so like nrf24_codec_decode it returns ESP_ERR_NOT_FINISHED mid sample.
+#define NRF24_CODEC_SEND_TIMEOUT_US 10000
+esp_err_t nrf24_codec_send(nrf24_t *dev, nrf24_codec_t *codec, const int32_t *values);
+esp_err_t nrf24_codec_get(nrf24_t *dev, nrf24_codec_t *codec, int32_t *values);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
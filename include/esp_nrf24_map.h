@@ -1,3 +1,5 @@
+#pragma once
+
 // Commands
 #define NRF24_CMD_R_REGISTER          0b00000000
 #define NRF24_CMD_W_REGISTER          0b00100000
@@ -35,6 +37,11 @@
 #define NRF24_MASK_ERX_ALL (0b00111111)
 
 #define NRF24_REG_SETUP_AW 0x03
+#define NRF24_AW_2BYTES 0b00 // Reserved in the datasheet, but the radio accepts it
+#define NRF24_AW_3BYTES 0b01
+#define NRF24_AW_4BYTES 0b10
+#define NRF24_AW_5BYTES 0b11
+
 #define NRF24_REG_SETUP_RETR 0x04
 
 #define NRF24_REG_RF_CH 0x05
@@ -55,6 +62,8 @@
 
 #define NRF24_REG_OBSERVE_TX 0x08
 #define NRF24_REG_RPD 0x09
+#define NRF24_MASK_RPD (1<<0)
+
 #define NRF24_REG_RX_ADDR_P0 0x0A
 #define NRF24_REG_RX_ADDR_P1 0x0B
 #define NRF24_REG_RX_ADDR_P2 0x0C
@@ -73,6 +82,9 @@
 
 
 #define NRF24_REG_FIFO_STATUS 0x17
+#define NRF24_MASK_RX_FULL (1<<1)
+#define NRF24_MASK_TX_EMPTY (1<<4)
+
 #define NRF24_REG_DYNPD 0x1C
 
 #define NRF24_REG_FEATURE 0x1D
@@ -0,0 +1,129 @@
+#pragma once
+
+#ifdef ESP_PLATFORM
+#include "esp_nrf24.h"
+#else
+// Host builds (see tools/) get everything but the radio ops, so a simulator can run the real update loop
+#include "esp_err.h"
+#include "esp_log.h"
+#include <stdint.h>
+#include <string.h>
+#define NRF24_TAG "NRF24"
+#define NRF24_CHECK_OK(ret) if((ret) != ESP_OK) return (ret)
+#endif
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Node addresses are octal digits read from the least significant end, each digit (1-5) picks a child pipe of the level above.
+// 0 is the gateway, 03 is its third child, 013 is the first child of 03, and so on down to NRF24_NETWORK_MAX_DEPTH levels.
+#define NRF24_NETWORK_GATEWAY 0
+#define NRF24_NETWORK_MAX_DEPTH 5
+#define NRF24_NETWORK_MAX_CHILDREN 5
+
+#define NRF24_NETWORK_QUEUE_LEN 8
+#define NRF24_NETWORK_MAX_RETRIES 3
+#define NRF24_NETWORK_MAX_HOPS (2*NRF24_NETWORK_MAX_DEPTH)
+
+#define NRF24_NETWORK_SETUP_RETR 0x15 // 500us auto retransmit delay, 5 retransmits per hop
+#define NRF24_NETWORK_ACK_TIMEOUT_US 10000
+
+#define NRF24_NETWORK_FRAME_LEN 32
+#define NRF24_NETWORK_HEADER_LEN 11
+#define NRF24_NETWORK_MAX_PAYLOAD (NRF24_NETWORK_FRAME_LEN - NRF24_NETWORK_HEADER_LEN)
+
+typedef struct {
+    uint16_t to_node;
+    uint16_t from_node;
+    uint8_t id;
+    uint8_t type;
+    uint8_t hops; // Relays the frame went through before reaching us
+    uint32_t queue_us; // Total time spent waiting in queues along the way, including the sender's
+} nrf24_network_header_t;
+
+typedef struct {
+    uint8_t frame[NRF24_NETWORK_FRAME_LEN];
+    uint8_t len;
+    uint8_t retries;
+    int64_t enqueued_us;
+} nrf24_network_entry_t;
+
+typedef struct {
+    nrf24_network_entry_t entries[NRF24_NETWORK_QUEUE_LEN];
+    uint8_t head;
+    uint8_t count;
+} nrf24_network_queue_t;
+
+bool nrf24_network_valid_address(uint16_t node);
+int nrf24_network_depth(uint16_t node);
+bool nrf24_network_next_hop(uint16_t node, uint16_t to_node, uint16_t *hop_node, uint8_t *hop_pipe);
+
+void nrf24_network_put_header(uint8_t *frame, const nrf24_network_header_t *header);
+void nrf24_network_get_header(const uint8_t *frame, nrf24_network_header_t *header);
+
+nrf24_network_entry_t *nrf24_network_queue_push(nrf24_network_queue_t *queue);
+nrf24_network_entry_t *nrf24_network_queue_peek(nrf24_network_queue_t *queue);
+void nrf24_network_queue_pop(nrf24_network_queue_t *queue);
+void nrf24_network_queue_rotate(nrf24_network_queue_t *queue);
+
+// Recently seen (from_node, id) pairs, a frame whose ack got lost is sent again and must only be delivered once
+#define NRF24_NETWORK_SEEN_LEN 16
+
+typedef struct {
+    uint16_t from_node;
+    uint8_t id;
+} nrf24_network_seen_t;
+
+typedef struct {
+    uint32_t sent;
+    uint32_t received;
+    uint32_t forwarded;
+    uint32_t dropped_queue_full;
+    uint32_t dropped_no_ack;
+    uint32_t dropped_invalid;
+    uint32_t dropped_duplicate;
+} nrf24_network_stats_t;
+
+typedef struct nrf24_network nrf24_network_t;
+
+// Everything the network layer needs from a radio. nrf24_network_init uses the nRF24L01+ behind net->radio,
+// nrf24_network_init_ops lets something else (like tools/nrf24_network_sim.c) stand in for it.
+typedef struct {
+    // Sends one frame to a pipe of hop_node and waits for the ack, ESP_ERR_TIMEOUT if none came. Must leave the radio listening.
+    esp_err_t (*transmit)(nrf24_network_t *net, uint16_t hop_node, uint8_t hop_pipe, uint8_t *frame, uint8_t len);
+    // Number of received frames waiting, negative on error
+    int (*available)(nrf24_network_t *net);
+    esp_err_t (*receive)(nrf24_network_t *net, uint8_t *frame, uint8_t *len);
+    int64_t (*time_us)(nrf24_network_t *net);
+} nrf24_network_ops_t;
+
+struct nrf24_network {
+    const nrf24_network_ops_t *ops;
+    void *radio; // Handed to the ops, the nrf24_t for nrf24_network_init
+    uint16_t node_address;
+    uint8_t next_id;
+    nrf24_network_queue_t tx_queue; // Our own frames and frames being relayed, waiting for the next hop
+    nrf24_network_queue_t rx_queue; // Frames addressed to us, waiting for nrf24_network_read
+    nrf24_network_seen_t seen[NRF24_NETWORK_SEEN_LEN];
+    uint8_t seen_head;
+    uint8_t seen_count;
+    nrf24_network_stats_t stats;
+};
+
+esp_err_t nrf24_network_init_ops(nrf24_network_t *net, const nrf24_network_ops_t *ops, void *radio, uint16_t node_address);
+esp_err_t nrf24_network_update(nrf24_network_t *net);
+
+esp_err_t nrf24_network_write(nrf24_network_t *net, uint16_t to_node, uint8_t type, const uint8_t *data, uint8_t len);
+int nrf24_network_available(nrf24_network_t *net);
+esp_err_t nrf24_network_read(nrf24_network_t *net, nrf24_network_header_t *header, uint8_t *data, uint8_t *len);
+
+#ifdef ESP_PLATFORM
+esp_err_t nrf24_network_init(nrf24_network_t *net, nrf24_t *dev, uint16_t node_address);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
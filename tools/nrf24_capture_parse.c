@@ -0,0 +1,67 @@
+// Host side parser for streams written by nrf24_capture_poll.
+// Build with: cc -Iinclude -o nrf24_capture_parse tools/nrf24_capture_parse.c
+// Usage: nrf24_capture_parse [capture.bin], reads stdin if no file is given.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_nrf24_capture_format.h"
+
+int main(int argc, char **argv) {
+    FILE *in = stdin;
+    if(argc > 1) {
+        in = fopen(argv[1], "rb");
+        if(in == NULL) {
+            perror(argv[1]);
+            return 1;
+        }
+    }
+
+    uint8_t header[NRF24_CAPTURE_MAGIC_LEN + 1];
+    if(fread(header, 1, sizeof(header), in) != sizeof(header) || memcmp(header, NRF24_CAPTURE_MAGIC, NRF24_CAPTURE_MAGIC_LEN) != 0) {
+        fprintf(stderr, "Not an nRF24 capture stream.\n");
+        return 1;
+    }
+
+    if(header[NRF24_CAPTURE_MAGIC_LEN] != NRF24_CAPTURE_VERSION) {
+        fprintf(stderr, "Unsupported capture version %i.\n", (int)header[NRF24_CAPTURE_MAGIC_LEN]);
+        return 1;
+    }
+
+    uint8_t record[NRF24_CAPTURE_MAX_RECORD];
+    uint32_t last_timestamp = 0;
+    uint64_t wraps = 0;
+    unsigned long frames = 0;
+    int len;
+
+    while((len = fgetc(in)) != EOF) {
+        if(len < NRF24_CAPTURE_RECORD_HEADER || len > NRF24_CAPTURE_MAX_RECORD - 1) {
+            fprintf(stderr, "Corrupt record length %i after %lu frames.\n", len, frames);
+            return 1;
+        }
+
+        if(fread(record, 1, len, in) != (size_t)len) {
+            fprintf(stderr, "Truncated record after %lu frames.\n", frames);
+            return 1;
+        }
+
+        uint32_t timestamp = (uint32_t)record[0] | ((uint32_t)record[1] << 8) | ((uint32_t)record[2] << 16) | ((uint32_t)record[3] << 24);
+        if(timestamp < last_timestamp)
+            wraps++;
+        last_timestamp = timestamp;
+
+        uint8_t channel = record[4];
+        uint8_t flags = record[5];
+
+        printf("%" PRIu64 " ch=%i rpd=%i%s ", (wraps << 32) + timestamp, (int)channel, (flags & NRF24_CAPTURE_FLAG_RPD) ? 1 : 0, (flags & NRF24_CAPTURE_FLAG_OVERFLOW) ? " overflow" : "");
+        for(int i = NRF24_CAPTURE_RECORD_HEADER; i < len; i++)
+            printf("%02x", record[i]);
+        printf("\n");
+
+        frames++;
+    }
+
+    fprintf(stderr, "%lu frames.\n", frames);
+    return 0;
+}
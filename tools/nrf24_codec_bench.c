@@ -0,0 +1,174 @@
+// Benchmark for the telemetry codec, reports payload size, packets per sample and encode/decode cost per sample.
+// Host build: cc -O2 -Iinclude -Itools/host -o nrf24_codec_bench tools/nrf24_codec_bench.c esp_nrf24_codec.c
+// Host usage: nrf24_codec_bench [samples] [fields] [keyframe_interval], without fields it runs every case in nrf24_bench_cases.
+// On target, add this file to an app's main component and the cases run from app_main.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_nrf24_codec.h"
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#define NRF24_BENCH_SAMPLES 256
+#define NRF24_BENCH_HAS_CYCLES 1
+#define NRF24_BENCH_CYCLES() ((uint64_t)esp_cpu_get_cycle_count()) // 32 bit, a few ms per run doesn't wrap it
+static uint64_t nrf24_bench_ns(void) {
+    return (uint64_t)esp_timer_get_time() * 1000;
+}
+#else
+#include <time.h>
+#define NRF24_BENCH_SAMPLES 100000
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define NRF24_BENCH_HAS_CYCLES 1
+#define NRF24_BENCH_CYCLES() __rdtsc()
+#else
+#define NRF24_BENCH_HAS_CYCLES 0
+#define NRF24_BENCH_CYCLES() 0
+#endif
+static uint64_t nrf24_bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+// Fields per sample, 6 fits one raw packet, the others need 2 and 4 without the codec
+static const int nrf24_bench_cases[] = {6, 16, 32};
+
+static void nrf24_bench_print_cycles(uint64_t cycles, int samples) {
+    if(NRF24_BENCH_HAS_CYCLES)
+        printf("  %13.1f", (double)cycles / samples);
+    else
+        printf("  %13s", "n/a");
+}
+
+static int nrf24_bench_run(int samples, int fields, int interval) {
+    nrf24_codec_t encoder;
+    nrf24_codec_t decoder;
+    if(nrf24_codec_init(&encoder, fields, interval) != ESP_OK || nrf24_codec_init(&decoder, fields, interval) != ESP_OK)
+        return 1;
+
+    // Random walk telemetry, each field changes on about a third of the samples by a few counts
+    int32_t *values = malloc((size_t)samples * fields * sizeof(int32_t));
+    uint8_t (*frames)[NRF24_CODEC_MAX_FRAMES][NRF24_CODEC_MAX_FRAME] = malloc((size_t)samples * sizeof(*frames));
+    uint8_t (*lens)[NRF24_CODEC_MAX_FRAMES] = malloc((size_t)samples * sizeof(*lens));
+    uint8_t *counts = malloc(samples);
+    if(values == NULL || frames == NULL || lens == NULL || counts == NULL) {
+        free(values);
+        free(frames);
+        free(lens);
+        free(counts);
+        return 1;
+    }
+
+    srand(1);
+    int32_t value[NRF24_CODEC_MAX_FIELDS];
+    for(int i = 0; i < fields; i++)
+        value[i] = rand() % 100000 - 50000;
+    for(int n = 0; n < samples; n++) {
+        for(int i = 0; i < fields; i++) {
+            if(rand() % 3 == 0)
+                value[i] += rand() % 11 - 5;
+            values[n*fields + i] = value[i];
+        }
+    }
+
+    int ret = 1;
+    uint64_t start_ns = nrf24_bench_ns();
+    uint64_t start_cycles = NRF24_BENCH_CYCLES();
+    for(int n = 0; n < samples; n++) {
+        if(nrf24_codec_encode(&encoder, &values[n*fields], frames[n], lens[n], &counts[n]) != ESP_OK) {
+            fprintf(stderr, "Encode failed on sample %i.\n", n);
+            goto out;
+        }
+    }
+    uint64_t encode_cycles = NRF24_BENCH_CYCLES() - start_cycles;
+    uint64_t encode_ns = nrf24_bench_ns() - start_ns;
+
+    int32_t decoded[NRF24_CODEC_MAX_FIELDS];
+    start_ns = nrf24_bench_ns();
+    start_cycles = NRF24_BENCH_CYCLES();
+    for(int n = 0; n < samples; n++) {
+        for(int f = 0; f < counts[n]; f++) {
+            esp_err_t expected = f == counts[n] - 1 ? ESP_OK : ESP_ERR_NOT_FINISHED;
+            if(nrf24_codec_decode(&decoder, frames[n][f], lens[n][f], decoded) != expected) {
+                fprintf(stderr, "Decode failed on sample %i frame %i.\n", n, f);
+                goto out;
+            }
+        }
+    }
+    uint64_t decode_cycles = NRF24_BENCH_CYCLES() - start_cycles;
+    uint64_t decode_ns = nrf24_bench_ns() - start_ns;
+
+    // Check every field once outside the timed loop
+    nrf24_codec_init(&decoder, fields, interval);
+    for(int n = 0; n < samples; n++) {
+        for(int f = 0; f < counts[n]; f++)
+            nrf24_codec_decode(&decoder, frames[n][f], lens[n][f], decoded);
+        for(int i = 0; i < fields; i++) {
+            if(decoded[i] != values[n*fields + i]) {
+                fprintf(stderr, "Mismatch on sample %i field %i.\n", n, i);
+                goto out;
+            }
+        }
+    }
+
+    uint64_t bytes = 0;
+    uint64_t packets = 0;
+    for(int n = 0; n < samples; n++) {
+        packets += counts[n];
+        for(int f = 0; f < counts[n]; f++)
+            bytes += lens[n][f];
+    }
+
+    int raw_bytes = fields * sizeof(int32_t);
+    int raw_packets = (raw_bytes + NRF24_CODEC_MAX_FRAME - 1) / NRF24_CODEC_MAX_FRAME;
+    printf("%6i  %8i  %9i  %11.2f  %11i  %13.2f  %9.1f", fields, interval, raw_bytes, (double)bytes / samples,
+        raw_packets, (double)packets / samples, (double)encode_ns / samples);
+    nrf24_bench_print_cycles(encode_cycles, samples);
+    printf("  %9.1f", (double)decode_ns / samples);
+    nrf24_bench_print_cycles(decode_cycles, samples);
+    printf("\n");
+    ret = 0;
+
+out:
+    free(values);
+    free(frames);
+    free(lens);
+    free(counts);
+    return ret;
+}
+
+static void nrf24_bench_header(int samples) {
+    printf("%i samples per case, timings and cycles are per sample\n", samples);
+    printf("fields  interval  raw_bytes  coded_bytes  raw_packets  coded_packets  encode_ns  encode_cycles  decode_ns  decode_cycles\n");
+}
+
+#ifdef ESP_PLATFORM
+void app_main(void) {
+    nrf24_bench_header(NRF24_BENCH_SAMPLES);
+    for(int i = 0; i < sizeof(nrf24_bench_cases) / sizeof(nrf24_bench_cases[0]); i++)
+        nrf24_bench_run(NRF24_BENCH_SAMPLES, nrf24_bench_cases[i], 16);
+}
+#else
+int main(int argc, char **argv) {
+    int samples = argc > 1 ? atoi(argv[1]) : NRF24_BENCH_SAMPLES;
+    int interval = argc > 3 ? atoi(argv[3]) : 16;
+    if(samples <= 0)
+        return 1;
+
+    nrf24_bench_header(samples);
+    if(argc > 2)
+        return nrf24_bench_run(samples, atoi(argv[2]), interval);
+
+    for(int i = 0; i < sizeof(nrf24_bench_cases) / sizeof(nrf24_bench_cases[0]); i++) {
+        if(nrf24_bench_run(samples, nrf24_bench_cases[i], interval) != 0)
+            return 1;
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,389 @@
+// Host side simulation of the tree network. Every node runs the real nrf24_network_update, write and read code through
+// nrf24_network_init_ops, only the radio underneath is simulated. Reports hop count, queueing delay and end to end latency
+// per depth plus the network layer's own counters.
+// Build with: cc -O2 -Iinclude -Itools/host -o nrf24_network_sim tools/nrf24_network_sim.c esp_nrf24_network.c
+// Usage: nrf24_network_sim [depth] [period_ms] [seconds] [poll_us] [loss_percent]
+//
+// Each node has its own clock, the node that is furthest behind runs next. A node wakes up to queue a reading, when a
+// frame lands in its RX FIFO and every poll_us while it has frames waiting for a retry, then calls nrf24_network_update.
+// The radio model at 1Mbps:
+//  - Every SPI transaction costs NRF24_SIM_SPI_US, transmit pays for the ones nrf24_network_radio_transmit makes plus the
+//    Tstby2a settling on the way to TX and back to RX.
+//  - Up to ARC hardware retransmits ARD apart, both taken from NRF24_NETWORK_SETUP_RETR (5 and 500us), then MAX_RT.
+//    The ack timeout caps the whole attempt at NRF24_NETWORK_ACK_TIMEOUT_US.
+//  - The frame and its ack are each lost with loss_percent, retransmits of a frame that did arrive are dropped by the
+//    receiver like the hardware does with the PID, so only a software retry after a lost ack makes a duplicate.
+//  - A node is deaf from the start to the end of its own transmit and while reading a payload (CE low), and a full
+//    3 frame RX FIFO doesn't ack.
+//  - RF collisions between nodes that aren't talking to each other are only covered by loss_percent.
+// Nodes run a whole transmit at once, so a node that starts sending while another's retransmits are still in the air
+// is only seen as deaf by frames that come after its own transmit started.
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_nrf24_network.h"
+
+#define NRF24_SIM_MAX_NODES (1 << 15)
+#define NRF24_SIM_RX_FIFO 3
+
+#define NRF24_SIM_SPI_US 25
+#define NRF24_SIM_TSTBY2A_US 130
+#define NRF24_SIM_ARD_US ((((NRF24_NETWORK_SETUP_RETR) >> 4) + 1) * 250)
+#define NRF24_SIM_ARC ((NRF24_NETWORK_SETUP_RETR) & 0x0F)
+
+// Preamble, 5 byte address, 9 bit packet control field, payload and 2 byte CRC, one bit per us at 1Mbps
+#define NRF24_SIM_AIR_US(len) ((1 + 5 + (len) + 2) * 8 + 9)
+
+typedef struct {
+    nrf24_network_t net;
+    int64_t now_us;
+    int64_t wake_us;
+    int64_t next_send_us;
+    int64_t deaf_from_us;
+    int64_t deaf_until_us;
+
+    uint8_t fifo[NRF24_SIM_RX_FIFO][NRF24_NETWORK_FRAME_LEN];
+    uint8_t fifo_len[NRF24_SIM_RX_FIFO];
+    int64_t fifo_arrival_us[NRF24_SIM_RX_FIFO];
+    uint8_t fifo_head;
+    uint8_t fifo_count;
+
+    uint32_t generated;
+} nrf24_sim_node_t;
+
+typedef struct {
+    uint64_t nodes;
+    uint64_t generated;
+    uint64_t dropped_write;
+    uint64_t delivered;
+    uint64_t duplicates;
+    uint64_t hops;
+    uint64_t queue_us;
+    uint64_t latency_us;
+    uint64_t max_latency_us;
+} nrf24_sim_depth_t;
+
+typedef struct {
+    int64_t time_us;
+    int node;
+} nrf24_sim_event_t;
+
+static nrf24_sim_node_t *nodes;
+static int node_count;
+static int node_index[NRF24_SIM_MAX_NODES];
+static nrf24_sim_depth_t depths[NRF24_NETWORK_MAX_DEPTH + 1];
+static int loss_percent;
+static int64_t poll_us;
+
+static uint8_t *delivered_map;
+static int delivered_map_bytes;
+
+// Min heap of wake ups, stale entries are skipped when popped
+static nrf24_sim_event_t *heap;
+static int heap_count;
+static int heap_size;
+
+static void nrf24_sim_heap_push(int64_t time_us, int node) {
+    if(heap_count == heap_size) {
+        heap_size = heap_size ? 2*heap_size : 1024;
+        heap = realloc(heap, heap_size * sizeof(nrf24_sim_event_t));
+        if(heap == NULL)
+            exit(1);
+    }
+
+    int i = heap_count++;
+    while(i > 0 && heap[(i - 1)/2].time_us > time_us) {
+        heap[i] = heap[(i - 1)/2];
+        i = (i - 1)/2;
+    }
+    heap[i].time_us = time_us;
+    heap[i].node = node;
+}
+
+static nrf24_sim_event_t nrf24_sim_heap_pop(void) {
+    nrf24_sim_event_t top = heap[0];
+    nrf24_sim_event_t last = heap[--heap_count];
+
+    int i = 0;
+    for(;;) {
+        int child = 2*i + 1;
+        if(child >= heap_count)
+            break;
+        if(child + 1 < heap_count && heap[child + 1].time_us < heap[child].time_us)
+            child++;
+        if(heap[child].time_us >= last.time_us)
+            break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = last;
+    return top;
+}
+
+static void nrf24_sim_wake(int n, int64_t time_us) {
+    if(time_us < nodes[n].wake_us) {
+        nodes[n].wake_us = time_us;
+        nrf24_sim_heap_push(time_us, n);
+    }
+}
+
+static bool nrf24_sim_lost(void) {
+    return rand() % 100 < loss_percent;
+}
+
+static esp_err_t nrf24_sim_transmit(nrf24_network_t *net, uint16_t hop_node, uint8_t hop_pipe, uint8_t *frame, uint8_t len) {
+    nrf24_sim_node_t *node = net->radio;
+    nrf24_sim_node_t *hop = &nodes[node_index[hop_node]];
+    int64_t start = node->now_us;
+
+    // TX_ADDR, RX_ADDR_P0, CONFIG and W_TX_PAYLOAD, then the PLL settles before the first packet goes out
+    int64_t air = start + 4*NRF24_SIM_SPI_US + NRF24_SIM_TSTBY2A_US;
+    int64_t done = -1;
+    bool stored = false;
+
+    for(int attempt = 0; attempt <= NRF24_SIM_ARC; attempt++) {
+        bool hop_deaf = hop->deaf_from_us <= air && air < hop->deaf_until_us;
+        bool hop_full = !stored && hop->fifo_count == NRF24_SIM_RX_FIFO; // No room means no ack either
+        if(!hop_deaf && !hop_full && !nrf24_sim_lost()) {
+            if(!stored) {
+                int slot = (hop->fifo_head + hop->fifo_count) % NRF24_SIM_RX_FIFO;
+                memcpy(hop->fifo[slot], frame, len);
+                hop->fifo_len[slot] = len;
+                hop->fifo_arrival_us[slot] = air + NRF24_SIM_AIR_US(len);
+                hop->fifo_count++;
+                nrf24_sim_wake(hop - nodes, hop->fifo_arrival_us[slot]);
+                stored = true;
+            }
+
+            if(!nrf24_sim_lost()) {
+                done = air + NRF24_SIM_AIR_US(len) + NRF24_SIM_TSTBY2A_US + NRF24_SIM_AIR_US(0);
+                break;
+            }
+        }
+
+        air += NRF24_SIM_AIR_US(len) + NRF24_SIM_ARD_US;
+    }
+
+    esp_err_t ret = ESP_OK;
+    if(done < 0) {
+        done = air; // MAX_RT once the last retransmit's ack wait runs out
+        ret = ESP_ERR_TIMEOUT;
+    }
+    if(done - start > NRF24_NETWORK_ACK_TIMEOUT_US) {
+        done = start + NRF24_NETWORK_ACK_TIMEOUT_US;
+        ret = ESP_ERR_TIMEOUT;
+    }
+
+    // FLUSH_TX on failure, STATUS, RX_ADDR_P0 and CONFIG, then settling back into RX
+    int64_t end = done + (ret == ESP_OK ? 3 : 4)*NRF24_SIM_SPI_US + NRF24_SIM_TSTBY2A_US;
+    node->deaf_from_us = start;
+    node->deaf_until_us = end;
+    node->now_us = end;
+    return ret;
+}
+
+static int nrf24_sim_available(nrf24_network_t *net) {
+    nrf24_sim_node_t *node = net->radio;
+    node->now_us += NRF24_SIM_SPI_US;
+    return node->fifo_count > 0 && node->fifo_arrival_us[node->fifo_head] <= node->now_us;
+}
+
+static esp_err_t nrf24_sim_receive(nrf24_network_t *net, uint8_t *frame, uint8_t *len) {
+    nrf24_sim_node_t *node = net->radio;
+
+    // R_RX_PL_WID and R_RX_PAYLOAD with CE low
+    node->deaf_from_us = node->now_us;
+    node->now_us += 2*NRF24_SIM_SPI_US + NRF24_SIM_TSTBY2A_US;
+    node->deaf_until_us = node->now_us;
+
+    memcpy(frame, node->fifo[node->fifo_head], node->fifo_len[node->fifo_head]);
+    *len = node->fifo_len[node->fifo_head];
+    node->fifo_head = (node->fifo_head + 1) % NRF24_SIM_RX_FIFO;
+    node->fifo_count--;
+    return ESP_OK;
+}
+
+static int64_t nrf24_sim_time_us(nrf24_network_t *net) {
+    nrf24_sim_node_t *node = net->radio;
+    return node->now_us;
+}
+
+static const nrf24_network_ops_t nrf24_sim_ops = {
+    .transmit = nrf24_sim_transmit,
+    .available = nrf24_sim_available,
+    .receive = nrf24_sim_receive,
+    .time_us = nrf24_sim_time_us
+};
+
+static void nrf24_sim_add_node(uint16_t address) {
+    nrf24_sim_node_t *node = &nodes[node_count];
+    if(nrf24_network_init_ops(&node->net, &nrf24_sim_ops, node, address) != ESP_OK)
+        exit(1);
+
+    node_index[address] = node_count;
+    node->deaf_until_us = -1;
+    node->wake_us = INT64_MAX;
+    node_count++;
+    depths[nrf24_network_depth(address)].nodes++;
+}
+
+static void nrf24_sim_put_u32(uint8_t *data, uint32_t value) {
+    for(int i = 0; i < 4; i++)
+        data[i] = (value >> (8*i)) & 0xFF;
+}
+
+static uint32_t nrf24_sim_get_u32(const uint8_t *data) {
+    uint32_t value = 0;
+    for(int i = 0; i < 4; i++)
+        value = value | ((uint32_t)data[i] << (8*i));
+    return value;
+}
+
+static void nrf24_sim_put_u64(uint8_t *data, uint64_t value) {
+    nrf24_sim_put_u32(data, value & 0xFFFFFFFF);
+    nrf24_sim_put_u32(&data[4], value >> 32);
+}
+
+static uint64_t nrf24_sim_get_u64(const uint8_t *data) {
+    return (uint64_t)nrf24_sim_get_u32(data) | ((uint64_t)nrf24_sim_get_u32(&data[4]) << 32);
+}
+
+// The gateway reads everything that made it, payload is the send time and a per source sequence number
+static void nrf24_sim_collect(nrf24_sim_node_t *gateway) {
+    nrf24_network_header_t header;
+    uint8_t data[NRF24_NETWORK_MAX_PAYLOAD];
+    uint8_t len;
+
+    while(nrf24_network_read(&gateway->net, &header, data, &len) == ESP_OK) {
+        nrf24_sim_depth_t *stats = &depths[nrf24_network_depth(header.from_node)];
+        uint32_t seq = nrf24_sim_get_u32(&data[8]);
+        uint8_t *map = &delivered_map[node_index[header.from_node] * delivered_map_bytes];
+        if(map[seq/8] & (1 << (seq%8))) {
+            stats->duplicates++;
+            continue;
+        }
+        map[seq/8] = map[seq/8] | (1 << (seq%8));
+
+        uint64_t latency = gateway->now_us - nrf24_sim_get_u64(data);
+        stats->delivered++;
+        stats->hops += header.hops;
+        stats->queue_us += header.queue_us;
+        stats->latency_us += latency;
+        if(latency > stats->max_latency_us)
+            stats->max_latency_us = latency;
+    }
+}
+
+int main(int argc, char **argv) {
+    int max_depth = argc > 1 ? atoi(argv[1]) : 4;
+    int64_t period_us = (argc > 2 ? atoll(argv[2]) : 10000) * 1000;
+    int64_t duration_us = (argc > 3 ? atoll(argv[3]) : 60) * 1000000;
+    poll_us = argc > 4 ? atoll(argv[4]) : 1000;
+    loss_percent = argc > 5 ? atoi(argv[5]) : 5;
+
+    if(max_depth < 1 || max_depth > NRF24_NETWORK_MAX_DEPTH || period_us <= 0 || duration_us <= 0 || poll_us <= 0) {
+        fprintf(stderr, "Usage: %s [depth 1-%i] [period_ms] [seconds] [poll_us] [loss_percent]\n", argv[0], NRF24_NETWORK_MAX_DEPTH);
+        return 1;
+    }
+
+    nodes = calloc(NRF24_SIM_MAX_NODES, sizeof(nrf24_sim_node_t));
+    if(nodes == NULL)
+        return 1;
+
+    srand(1);
+
+    // Full tree, level by level, children of each node get the next octal digit up
+    nrf24_sim_add_node(NRF24_NETWORK_GATEWAY);
+    int level_start = 0;
+    for(int depth = 1; depth <= max_depth; depth++) {
+        int level_end = node_count;
+        for(int parent = level_start; parent < level_end; parent++) {
+            for(int child = 1; child <= NRF24_NETWORK_MAX_CHILDREN; child++)
+                nrf24_sim_add_node(nodes[parent].net.node_address | (child << (3*(depth - 1))));
+        }
+        level_start = level_end;
+    }
+
+    delivered_map_bytes = (int)(duration_us / period_us / 8 + 1);
+    delivered_map = calloc((size_t)node_count * delivered_map_bytes, 1);
+    if(delivered_map == NULL)
+        return 1;
+
+    for(int i = 1; i < node_count; i++) {
+        nodes[i].next_send_us = rand() % period_us;
+        nrf24_sim_wake(i, nodes[i].next_send_us);
+    }
+
+    while(heap_count > 0) {
+        nrf24_sim_event_t event = nrf24_sim_heap_pop();
+        nrf24_sim_node_t *node = &nodes[event.node];
+        if(event.time_us != node->wake_us)
+            continue;
+        if(event.time_us >= duration_us)
+            break;
+
+        node->wake_us = INT64_MAX;
+        if(node->now_us < event.time_us)
+            node->now_us = event.time_us;
+
+        // Every sensor queues a reading for the gateway once per period
+        if(event.node != 0 && node->next_send_us <= node->now_us) {
+            uint8_t data[12];
+            nrf24_sim_depth_t *stats = &depths[nrf24_network_depth(node->net.node_address)];
+            nrf24_sim_put_u64(data, (uint64_t)node->now_us);
+            nrf24_sim_put_u32(&data[8], node->generated++);
+            stats->generated++;
+            if(nrf24_network_write(&node->net, NRF24_NETWORK_GATEWAY, 0, data, sizeof(data)) != ESP_OK)
+                stats->dropped_write++;
+            node->next_send_us += period_us;
+        }
+
+        if(nrf24_network_update(&node->net) != ESP_OK) {
+            fprintf(stderr, "Update failed on node 0%o.\n", node->net.node_address);
+            return 1;
+        }
+
+        if(event.node == 0)
+            nrf24_sim_collect(node);
+
+        // Next reading, next frame in the FIFO, or the next poll while anything is waiting to go out
+        if(event.node != 0)
+            nrf24_sim_wake(event.node, node->next_send_us);
+        if(node->fifo_count > 0)
+            nrf24_sim_wake(event.node, node->fifo_arrival_us[node->fifo_head] > node->now_us ? node->fifo_arrival_us[node->fifo_head] : node->now_us);
+        if(node->net.tx_queue.count > 0)
+            nrf24_sim_wake(event.node, node->now_us + poll_us);
+    }
+
+    nrf24_network_stats_t total = {0};
+    for(int i = 0; i < node_count; i++) {
+        nrf24_network_stats_t *stats = &nodes[i].net.stats;
+        total.sent += stats->sent;
+        total.received += stats->received;
+        total.forwarded += stats->forwarded;
+        total.dropped_queue_full += stats->dropped_queue_full;
+        total.dropped_no_ack += stats->dropped_no_ack;
+        total.dropped_invalid += stats->dropped_invalid;
+        total.dropped_duplicate += stats->dropped_duplicate;
+    }
+
+    printf("%i nodes, depth %i, one frame per node every %" PRId64 "ms for %" PRId64 "s, %" PRId64 "us poll, %i%% loss per frame and per ack\n",
+        node_count, max_depth, period_us / 1000, duration_us / 1000000, poll_us, loss_percent);
+    printf("depth  nodes  generated  delivered  dup_delivered  avg_hops  avg_queue_ms  avg_latency_ms  max_latency_ms\n");
+    for(int depth = 1; depth <= max_depth; depth++) {
+        nrf24_sim_depth_t *stats = &depths[depth];
+        double delivered = stats->delivered > 0 ? (double)stats->delivered : 1;
+        printf("%5i  %5" PRIu64 "  %9" PRIu64 "  %9" PRIu64 "  %13" PRIu64 "  %8.2f  %12.2f  %14.2f  %14.2f\n",
+            depth, stats->nodes, stats->generated, stats->delivered, stats->duplicates,
+            stats->hops / delivered, stats->queue_us / delivered / 1000, stats->latency_us / delivered / 1000, stats->max_latency_us / 1000.0);
+    }
+    printf("all nodes: sent %" PRIu32 ", forwarded %" PRIu32 ", received %" PRIu32 ", dropped queue_full %" PRIu32 ", no_ack %" PRIu32 ", invalid %" PRIu32 ", duplicate %" PRIu32 "\n",
+        total.sent, total.forwarded, total.received, total.dropped_queue_full, total.dropped_no_ack, total.dropped_invalid, total.dropped_duplicate);
+
+    free(nodes);
+    free(delivered_map);
+    free(heap);
+    return 0;
+}